@@ -60,7 +60,8 @@
 
 */
 int main(void) {
-	sm_t mysm;
+	statemachine_data_t mydata = { false };
+	sm_t mysm = SM_INIT(&mydata);
 	sm_state_t* current;
 
 	current = sm_init(&mysm, &statemachine_states[A]);
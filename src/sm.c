@@ -55,6 +55,10 @@
                - state entry and exit actions
                - do actions by starting/stopping (proto)threads in entry/exit action respectively
                - transition effects (actions directly associated with a specific transition)
+               - asynchronous actions reporting back by completion events, see sm_async.h
+               - completion transitions (triggerless transitions taken after the entry action)
+               - replacing state tables of running statemachines, see sm_table_publish()
+               - timed events in real or deterministic virtual time, see sm_sim.h
 
                Limitations of this implementation: \n\n
 
@@ -64,6 +68,7 @@
                - transition fork/join not supported
                - history states not supported
                - sending events in entry/exit/transition/effect functions not allowed (due to recursion)
+                 (post them to an event queue instead, see sm_queue.h)
 
                References: ISBN 3-8273-1486-0   Das UML-Benutzerhandbuch
 
@@ -81,18 +86,214 @@
 #include "sm.h"
 #include <stddef.h>
 
+
+
+/*!
+   \brief      Performs an external or self transition
+   \details    Invokes the exit action of the source state, the transition effect and
+               the entry action of the target state, if any.
+
+   \param[in,out]    sm       State machine instance
+   \param[in]        source   Source state of the transition
+   \param[in]        target   Target state of the transition
+   \param[in]        event    Triggering event
+   \param[in,out]    data     Data associated with the event
+*/
+static void sm_transit(sm_t* sm, sm_state_t* source, sm_state_t* target, event_t event, void* data)
+{
+   /* invoke exit action of source state, if any */
+   if(source->exit_action)
+      source->exit_action(sm,event,data);
+
+   /* invoke transition effect, if any */
+   if(sm->effect)
+   {
+      sm->effect(sm,event,data);
+      sm->effect = NULL;
+   }
+
+   /* perform transition  */
+   sm->state = target;
+
+   /* invoke entry action of target state, if any */
+   if(target->entry_action)
+      target->entry_action(sm,event,data);
+}
+
+/*!
+   \brief      Checks whether a state is a valid target of a statemachine
+   \details    A statemachine bound to a versioned state table may only enter states of that table.
+
+   \param[in]        sm       State machine instance
+   \param[in]        state    State to be checked
+
+   \returns    true if the state belongs to the table the statemachine is bound to, or the
+               statemachine is not bound to any table. false otherwise.
+*/
+static bool sm_table_contains(const sm_t* sm, const sm_state_t* state)
+{
+   if(!sm->table) return true;
+
+   return state >= sm->table->states && state < sm->table->states + sm->table->count;
+}
+
+/*!
+   \brief      Takes the completion transitions of the current state
+   \details    A completion transition is a transition without trigger, taken as soon as the
+               entry action of its source state has finished. The transitions function of the
+               current state is queried with SM_EVENT_COMPLETION until it returns no transition.
+               Chains of pass-through states are thereby finished without dispatching further events.
+               At most SM_COMPLETION_LIMIT completion transitions are taken in a row. If the chain
+               is longer, e.g. due to a cycle, it is cut and the overrun flag of the statemachine is set.
+
+   \param[in,out]    sm       State machine instance
+
+   \returns    State of the state machine after the completion transitions.
+               NULL if a completion transition leads to a state not belonging to the versioned
+               state table of the statemachine.
+*/
+static sm_state_t* sm_complete(sm_t* sm)
+{
+   sm_state_t* target;
+   unsigned int chain;
+
+   for(chain = 0; ; chain++)
+   {
+      sm->effect = NULL;
+
+      if(!sm->state->transitions)
+         break;
+
+      target = (sm_state_t*)sm->state->transitions(sm,SM_EVENT_COMPLETION,NULL);
+
+      if(!target)
+         break;
+
+      /* cycle of completion transitions, stay in current state */
+      if(chain >= SM_COMPLETION_LIMIT)
+      {
+         sm->effect = NULL;
+         sm->overrun = true;
+         break;
+      }
+
+      /* state of another table, reject transition */
+      if(!sm_table_contains(sm,target))
+      {
+         sm->effect = NULL;
+         return NULL;
+      }
+
+      sm_transit(sm,sm->state,target,SM_EVENT_COMPLETION,NULL);
+   }
+
+   return sm->state;
+}
+
+
+/*!
+   \brief      Releases a reference to a versioned state table
+   \details    Once the last reference to a table with a published successor is released, the
+               table retires and in turn releases the reference it holds to its successor.
+               Has to be invoked with the tables locked.
+
+   \param[in,out]    table    Versioned state table
+*/
+static void sm_table_release(sm_table_t* table)
+{
+   while(table && !--table->users)
+      table = table->successor;
+}
+
+/*!
+   \brief      Migrates a statemachine to the latest version of its state table
+   \details    If a newer version of the state table the statemachine is bound to has been
+               published, the current state is mapped by its state id to the newer version.
+               No exit or entry actions are invoked, as the statemachine stays in the same state.
+               Unless a newer version has been published, this costs a single pointer comparison
+               without locking. The successor and its map are read with the tables locked, so
+               SM_TABLE_LOCK has to order memory if statemachines are dispatched by several threads.
+
+   \param[in,out]    sm       State machine instance
+
+   \returns    true if the statemachine is bound to the latest version, or to none.
+               false if its state does not belong to its table, so it cannot be mapped.
+*/
+static bool sm_migrate(sm_t* sm)
+{
+   sm_table_t* table = sm->table;
+   sm_table_t* successor;
+   const size_t* map;
+   size_t id;
+
+   /* unlocked check is a hint only, successor and map are read with the tables locked */
+   while(table && table->successor)
+   {
+      if(!sm_table_contains(sm,sm->state))
+         return false;
+
+      SM_TABLE_LOCK();
+
+      successor = table->successor;
+      map = table->map;
+
+      id = sm_state_id(table->states,sm->state);
+
+      if(map)
+         id = map[id];
+
+      successor->users++;
+      sm_table_release(table);
+
+      SM_TABLE_UNLOCK();
+
+      sm->state = (sm_state_t*)&successor->states[id];
+      sm->table = table = successor;
+   }
+
+   return true;
+}
+
+
+/*!
+   \brief      Releases the versioned state table the statemachine is bound to, if any
+
+   \param[in,out]    sm       State machine instance
+*/
+static void sm_unbind(sm_t* sm)
+{
+   if(!sm->table) return;
+
+   SM_TABLE_LOCK();
+   sm_table_release(sm->table);
+   SM_TABLE_UNLOCK();
+
+   sm->table = NULL;
+}
+
 /*!
-   \brief      Action to carry out in case of a specific transition
-   \details    You can associate a transition with an effect, which is an optional activity
-               performed when a specific transition fires. The associated function may only be set
-               within a transition function. It will be reset to NULL again after state transition.
-               Transition effects will not work for internal state transitions.
+   \brief      Transits from the initial pseudo state to a state
+   \details    Sets the state and invokes its entry action, followed by completion transitions.
 
-   \remark     Move to sm instance in future (for future thread safe version) or to transition function as parameter
- */
-sm_transition_effect_fp sm_transition_effect = NULL;
+   \param[in,out]    sm       State machine instance
+   \param[in]        state    State to initialize the state machine with
 
+   \returns    State of the state machine after initial transition and completion transitions, if any.
+*/
+static sm_state_t* sm_enter(sm_t* sm, const sm_state_t* state)
+{
+   sm->overrun = false;
 
+   /* perform transition, before the entry action like for any other transition */
+   sm->state = (sm_state_t*)state;
+
+   /* invoke the initial states entry action */
+   if(state->entry_action)
+      state->entry_action(sm,SM_EVENT_INIT,NULL);
+
+   /* take completion transitions of the initial state, if any */
+   return sm_complete(sm);
+}
 
 /*!
    \brief      Initialize a statemachine with a provided initial state
@@ -101,6 +302,9 @@ sm_transition_effect_fp sm_transition_effect = NULL;
                The Initial State from the UML Statechart Diagram marks the entry point and the initial statemachine state.
                The notation for the Initial State is a small solid filled circle. There can only be one Initial State on a diagram.
                Invoking this function transits from initial pseudo state to the initial statemachine state.
+               The data of the statemachine has to be set before, as it is accessed by the entry action.
+               A statemachine bound to a versioned state table is released from it. Therefore the
+               statemachine has to be initialized by SM_INIT or terminated before.
 
 
    \param[in,out]    sm       State machine instance
@@ -108,7 +312,7 @@ sm_transition_effect_fp sm_transition_effect = NULL;
                               Has to be a valid state of the state machines state table.
 
 
-   \returns    State of the state machine after initial transition.
+   \returns    State of the state machine after initial transition and completion transitions, if any.
                NULL if initialization failed
 
    \ingroup SmInterface
@@ -117,15 +321,53 @@ sm_state_t* sm_init(sm_t* sm, const sm_state_t* state)
 {
    if(!sm || !state) return NULL;
 
+   sm_unbind(sm);
 
-   /* invoke the initial states entry action */
-   if(state->entry_action)
-      state->entry_action(SM_EVENT_INIT,NULL);
+   return sm_enter(sm,state);
+}
 
-   /* perform transition */
-   sm->state = (sm_state_t*)state;
+/*!
+   \brief      Initialize a statemachine with a state of a versioned state table
+   \details    Initializes the statemachine like sm_init() and binds it to the versioned state table.
+               If newer versions of the table have been published already, the statemachine
+               is bound to the latest one, with the state id mapped accordingly.
+               The statemachine migrates to newer versions of the state table published
+               by sm_table_publish() later on at its next sm_send().
+               Like for sm_init(), the statemachine has to be initialized by SM_INIT or terminated before.
+
+   \param[in,out]    sm       State machine instance
+   \param[in,out]    table    Versioned state table
+   \param[in]        id       State id of the state to initialize the state machine with
+
+   \returns    State of the state machine after initial transition and completion transitions, if any.
+               NULL if initialization failed
+
+   \ingroup SmInterface
+*/
+sm_state_t* sm_init_table(sm_t* sm, sm_table_t* table, size_t id)
+{
+   if(!sm || !table || id >= table->count) return NULL;
+
+   sm_unbind(sm);
 
-   return (sm_state_t*)state;
+   /* bind to latest version before any action runs, so publishing cannot miss the statemachine */
+   SM_TABLE_LOCK();
+
+   while(table->successor)
+   {
+      if(table->map)
+         id = table->map[id];
+
+      table = table->successor;
+   }
+
+   table->users++;
+
+   SM_TABLE_UNLOCK();
+
+   sm->table = table;
+
+   return sm_enter(sm,&table->states[id]);
 }
 
 /*!
@@ -142,9 +384,12 @@ void sm_terminate(sm_t *sm)
    if(!sm || !sm->state) return;
 
    if(sm->state->exit_action)
-      sm->state->exit_action(SM_EVENT_EXIT,NULL);
+      sm->state->exit_action(sm,SM_EVENT_EXIT,NULL);
 
    sm->state = NULL;
+
+   /* release versioned state table, if any */
+   sm_unbind(sm);
 }
 
 /*!
@@ -157,8 +402,9 @@ void sm_terminate(sm_t *sm)
    \param[in,out]    data     Data associated with the event
 
 
-   \returns    State of the state machine after transition.
-               NULL if transition failed.
+   \returns    State of the state machine after transition and completion transitions, if any.
+               NULL if transition failed, e.g. because the target state does not belong to the
+               versioned state table the statemachine is bound to.
 
 
    \ingroup SmInterface
@@ -170,40 +416,109 @@ sm_state_t* sm_send(sm_t* sm, event_t event, void* data)
 
    if(!sm || !sm->state) return NULL;
 
+   /* switch to latest version of the state table, if any */
+   if(!sm_migrate(sm)) return NULL;
+
    source = sm->state;
 
-   sm_transition_effect = NULL;
+   sm->effect = NULL;
+   sm->overrun = false;
 
    /* prepare transition from source to target state*/
    if(source->transitions)
-      target = (sm_state_t*)source->transitions(event,data);
+      target = (sm_state_t*)source->transitions(sm,event,data);
+
+   /* state of another table, reject transition */
+   if(target && !sm_table_contains(sm,target))
+   {
+      sm->effect = NULL;
+      return NULL;
+   }
 
    /* external or self transition */
    if(target)
    {
-      /* invoke exit action of source state, if any */
-      if(source->exit_action)
-         source->exit_action(event,data);
+      sm_transit(sm,source,target,event,data);
 
-      /* invoke transition effect, if any */
-      if(sm_transition_effect)
-      {
-         sm_transition_effect(event,data);
-         sm_transition_effect = NULL;
-      }
+      /* take completion transitions of the target state, if any */
+      return sm_complete(sm);
+   }
 
-      /* perform transition  */
-      sm->state = target;
+   /* none or internal transition */
+   return source;
+}
 
-      /* invoke entry action of target state, if any */
-      if(target->entry_action)
-         target->entry_action(event,data);
+/*!
+   \brief      Publishes a newer version of a versioned state table
+   \details    Statemachines bound to the table keep running without interruption. Each of them
+               migrates to the successor by state id at its next sm_send(). States that were
+               renamed, reordered or removed in the successor are mapped explicitly by the
+               map, which holds the successor's state id for every state id of the table.
+               The table and the map have to stay valid until sm_table_retired() returns true.
+
+   \param[in,out]    table       Versioned state table currently in use
+   \param[in,out]    successor   Newer version of the state table
+   \param[in]        map         State id of the successor for each state id of the table,
+                                 NULL if the state ids are unchanged
+
+   \returns    true if the successor has been published. false if the arguments are invalid,
+               a successor has already been published or the map refers to invalid states.
 
-      return target;
+   \ingroup SmInterface
+*/
+bool sm_table_publish(sm_table_t* table, sm_table_t* successor, const size_t* map)
+{
+   size_t id;
+
+   if(!table || !successor || table == successor) return false;
+
+   /* every state has to map to a valid state of the successor */
+   for(id = 0; id < table->count; id++)
+   {
+      if((map ? map[id] : id) >= successor->count)
+         return false;
    }
 
-   /* none or internal transition */
-   return source;
+   SM_TABLE_LOCK();
+
+   if(table->successor)
+   {
+      SM_TABLE_UNLOCK();
+      return false;
+   }
+
+   table->map = map;
+   table->successor = successor;
+
+   /* successor may not retire before the table, as statemachines still pass through it */
+   if(table->users)
+      successor->users++;
+   SM_TABLE_UNLOCK();
+
+   return true;
 }
 
+/*!
+   \brief      Checks whether a versioned state table may be released
+   \details    A table is retired, once a successor has been published, all statemachines
+               bound to it have migrated or terminated and all its predecessors have retired,
+               as statemachines of a predecessor migrate through the table.
+
+   \param[in]        table    Versioned state table
+
+   \returns    true if the table is retired. false otherwise.
 
+   \ingroup SmInterface
+*/
+bool sm_table_retired(const sm_table_t* table)
+{
+   bool retired;
+
+   if(!table) return false;
+
+   SM_TABLE_LOCK();
+   retired = table->successor && !table->users;
+   SM_TABLE_UNLOCK();
+
+   return retired;
+}
@@ -55,6 +55,10 @@
                - state entry and exit actions
                - do actions by starting/stopping (proto)threads in entry/exit action respectively
                - transition effects (actions directly associated with a specific transition)
+               - asynchronous actions reporting back by completion events, see sm_async.h
+               - completion transitions (triggerless transitions taken after the entry action)
+               - replacing state tables of running statemachines, see sm_table_publish()
+               - timed events in real or deterministic virtual time, see sm_sim.h
 
                Limitations of this implementation: \n\n
 
@@ -64,6 +68,7 @@
                - transition fork/join not supported
                - history states not supported
                - sending events in entry/exit/transition/effect functions not allowed (due to recursion)
+                 (post them to an event queue instead, see sm_queue.h)
 
                __Changelog__
 
@@ -77,10 +82,30 @@
 #ifndef SM_H_
 #define SM_H_
 
+#include <stddef.h>
+#include <stdbool.h>
+
 /*! Definition of event id to initialize a statemachine, must not be sent by the user*/
 #define SM_EVENT_INIT (~((event_t)0))
 /*! Definition of event id to terminate a statemachine, must not be sent by the user*/
 #define SM_EVENT_EXIT (SM_EVENT_INIT-1)
+/*! Definition of event id to query completion transitions of a state, must not be sent by the user*/
+#define SM_EVENT_COMPLETION (SM_EVENT_INIT-2)
+
+#ifndef SM_COMPLETION_LIMIT
+/*! Maximum number of completion transitions taken in a row, to catch cycles of completion transitions. A longer chain is cut and reported by the overrun flag of the statemachine */
+#define SM_COMPLETION_LIMIT 16
+#endif
+
+#ifndef SM_TABLE_LOCK
+/*! Enter critical section protecting versioned state tables, empty by default. Has to provide acquire/release ordering if statemachines are dispatched by several threads. Has to be defined when compiling sm.c, e.g. by -D options or a configuration header, defining it in a file including sm.h has no effect */
+#define SM_TABLE_LOCK()
+#endif
+
+#ifndef SM_TABLE_UNLOCK
+/*! Leave critical section protecting versioned state tables, empty by default. Has to be defined when compiling sm.c */
+#define SM_TABLE_UNLOCK()
+#endif
 
 
 /*!
@@ -96,6 +121,11 @@ typedef unsigned int event_t;
 */
 typedef struct sm_state_t sm_state_t ;
 
+/*!
+   Forward declaration of sm structure
+*/
+typedef struct sm_t sm_t;
+
 
 /*!
     \brief     Callback function type for entry actions
@@ -103,11 +133,12 @@ typedef struct sm_state_t sm_state_t ;
                entry to a state. Entry actions are associated with states, not transitions. Regardless
                of how a state is entered, its entry action will be executed.
 
+   \param      sm       State machine instance, giving access to its (object-) data
    \param      event    Triggering event
    \param      data     Data associated with the event
 
 */
-typedef void(*sm_entry_action_fp)(event_t event, void* data);
+typedef void(*sm_entry_action_fp)(sm_t* sm, event_t event, void* data);
 
 /*!
     \brief     Callback function type for exit actions
@@ -115,11 +146,12 @@ typedef void(*sm_entry_action_fp)(event_t event, void* data);
                exit from a state. Exit actions are associated with states, not transitions. Regardless
                of how a state is left, its exit action will be executed.
 
+   \param      sm       State machine instance, giving access to its (object-) data
    \param      event    Triggering event
    \param      data     Data associated with the event
 
 */
-typedef void(*sm_exit_action_fp)(event_t event, void* data);
+typedef void(*sm_exit_action_fp)(sm_t* sm, event_t event, void* data);
 
 
 /*!
@@ -128,33 +160,32 @@ typedef void(*sm_exit_action_fp)(event_t event, void* data);
                it is called the triggering event, or simply the trigger. This function has to be
                implemented by the state machine designer for each state of the state machine.
 
+               After a state has been entered, the function is invoked with SM_EVENT_COMPLETION
+               to query its completion transition, if any.
+
+   \param      sm       State machine instance, giving access to its (object-) data
    \param      event    Triggering event
    \param      data     Data associated with the event
 
    \returns    New state in case of external transition. Same state as before in case of
                self transition. NULL in case of internal or no transition.
 */
-typedef const sm_state_t*(*sm_transitions_fp)(event_t event, void* data);
+typedef const sm_state_t*(*sm_transitions_fp)(sm_t* sm, event_t event, void* data);
 
 /*!
    \brief      Callback function type for transition effects
    \details    Switching from one state to another is called state transition.
                An effect specifies an optional behavior to be performed when the transition fires.
-               The transition effect has to be set in the transition function and is invoked after
-               exit of the source state and before entry of the target state.
+               The transition effect has to be set in the transition function as effect of the
+               statemachine instance and is invoked after exit of the source state and before entry
+               of the target state. It is reset to NULL again after state transition.
+               Transition effects will not work for internal state transitions.
 
+   \param      sm       State machine instance, giving access to its (object-) data
    \param      event    Triggering event
    \param      data     Data associated with the event
 */
-typedef void(*sm_transition_effect_fp)(event_t event, void* data);
-
-
-/*!
-    \brief     Callback function type for transition effects
-    \details   Specifies an optional behavior to be performed when the transition fires.
-
- */
-extern sm_transition_effect_fp sm_transition_effect; /*!< global variable for the transition effect */
+typedef void(*sm_transition_effect_fp)(sm_t* sm, event_t event, void* data);
 
 /*!
    A state captures the relevant aspects of the system's history very efficiently.
@@ -168,14 +199,64 @@ struct sm_state_t {
    sm_exit_action_fp exit_action;      /*!< exit action to be performed if the state gets exited */
 };
 
+/*!
+   Forward declaration of sm_table structure
+*/
+typedef struct sm_table_t sm_table_t;
+
+/*!
+    \brief     Versioned state table declaration
+    \details   Wraps a state table, so a newer version of it can be published while statemachines
+               are running. Statemachines bound to the table migrate to the newer version by state id
+               at their next sm_send(). A table may be released once sm_table_retired() returns true.
+               The transitions functions of each version have to return states of their own
+               table. Transitions to states of another table are rejected by sm_send().
+               Reuse of transitions functions across versions is therefore limited to
+               functions not returning any state.
+               If statemachines are dispatched by several threads, SM_TABLE_LOCK and SM_TABLE_UNLOCK
+               have to be defined when compiling sm.c.
+               Use SM_TABLE_INIT to initialize it.
+*/
+struct sm_table_t {
+   const sm_state_t *states;        /*!< State table of this version */
+   size_t count;                    /*!< Number of states of the state table */
+   const size_t *map;               /*!< Maps state ids of this version to state ids of the successor, NULL for identity */
+   sm_table_t * volatile successor; /*!< Newer version of the state table, NULL if not published yet. Written and read with the tables locked, except for the unlocked check of sm_send() */
+   size_t users;                    /*!< Number of statemachines bound to this version, plus predecessors not retired yet */
+};
+
+/*!
+   \brief      Preprocessor macro to initialize a versioned state table.
+   \details    Preprocessor macro to initialize a versioned state table.
+
+   \param[in]     states_ptr  Pointer to the state table
+   \param[in]     state_count Number of states of the state table
+*/
+#define SM_TABLE_INIT(states_ptr,state_count) \
+   { (states_ptr), (state_count), NULL, NULL, 0 }
+
 /*!
     \brief     Statemachine declaration
     \details   Holds the current state and data associated with the statemachine.
+               The statemachine is passed to all entry/exit/transition/effect functions, so
+               any number of statemachines may share one state table, each with its own data.
 */
-typedef struct {
+struct sm_t {
    sm_state_t *state;      /*!< Current state of the statemachine */
    void *data;             /*!< (Object-) Data associated with the statemachine */
-}sm_t;
+   sm_table_t *table;      /*!< Versioned state table the statemachine is bound to, NULL if none */
+   sm_transition_effect_fp effect; /*!< Transition effect, may only be set within a transition function */
+   bool overrun;           /*!< Set if the last sm_init()/sm_send() cut a chain of completion transitions at SM_COMPLETION_LIMIT */
+};
+
+/*!
+   \brief      Preprocessor macro to initialize a statemachine before its first sm_init().
+   \details    Preprocessor macro to initialize a statemachine before its first sm_init().
+
+   \param[in]     data_ptr    Pointer to the (object-) data of the statemachine
+*/
+#define SM_INIT(data_ptr) \
+   { NULL, (data_ptr), NULL, NULL, false }
 
 
 /*!
@@ -193,8 +274,11 @@ typedef struct {
 
 
 sm_state_t* sm_init(sm_t* sm, const sm_state_t* state);
+sm_state_t* sm_init_table(sm_t* sm, sm_table_t* table, size_t id);
 void sm_terminate(sm_t *sm);
 sm_state_t* sm_send(sm_t* sm, event_t event, void* data);
+bool sm_table_publish(sm_table_t* table, sm_table_t* successor, const size_t* map);
+bool sm_table_retired(const sm_table_t* table);
 
 
 #endif /* SM_H_ */
@@ -0,0 +1,132 @@
+/*! \copyright
+               Copyright (c) 2013, marco@bacchi.at
+               All rights reserved.
+
+               Redistribution and use in source and binary forms, with or without
+               modification, are permitted provided that the following conditions
+               are met:
+               1. Redistributions of source code must retain the above copyright
+                notice, this list of conditions and the following disclaimer.
+               2. Redistributions in binary form must reproduce the above copyright
+                notice, this list of conditions and the following disclaimer in the
+                documentation and/or other materials provided with the distribution.
+               3. The name of the author may not be used to endorse or promote
+                products derived from this software without specific prior
+                written permission.
+
+               THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS
+               OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+               ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+               DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+               GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+               INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+               WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+               NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+   \file       sm_async.c
+   \version    0000
+   \authors    marco@bacchi.at
+   \date       2013
+
+   \brief      Asynchronous actions for UML state machines - implementation
+
+   \details    Long lasting work is submitted as asynchronous job from within entry/exit/transition/effect
+               functions. The job is run by an executor and its completion is reported back to the owning
+               statemachine by posting a completion event to its event queue.
+
+               __Changelog__
+
+               Revision|Date    |Name  |Change
+               --------|--------|------|-------------------------------------------------
+               0000    |00.00.00|bacmar|Detailed Change Text
+*/
+
+#include "sm_async.h"
+#include <stddef.h>
+
+/*!
+   \brief      Executor for asynchronous jobs
+   \details    Hands over submitted jobs to e.g. a worker thread pool. If NULL, the
+               jobs are run immediately within sm_async_submit().
+ */
+sm_async_executor_fp sm_async_executor = NULL;
+
+
+
+/*!
+   \brief      Submits an asynchronous job
+   \details    Prepares the job and hands it over to the executor. May be invoked from within
+               entry/exit/transition/effect functions.
+
+   \param[out]       async    Asynchronous job, has to stay valid until its completion event got posted
+   \param[in]        queue    Event queue of the owning statemachine
+   \param[in]        work     Work to be done
+   \param[in]        data     Data associated with the job
+
+   \returns    true if the job has been submitted. false if the arguments are invalid
+               or, without executor, the completion event could not be posted. In the latter
+               case the work has been done and posting may be retried by sm_async_post().
+
+   \ingroup SmInterface
+*/
+bool sm_async_submit(sm_async_t *async, sm_queue_t *queue, sm_async_work_fp work, void *data)
+{
+   if(!async || !queue || !work) return false;
+
+   async->work = work;
+   async->data = data;
+   async->queue = queue;
+
+   if(!sm_async_executor)
+      return sm_async_run(async);
+
+   sm_async_executor(async);
+
+   return true;
+}
+
+/*!
+   \brief      Runs an asynchronous job
+   \details    Performs the work of the job and posts the resulting completion event to the
+               event queue of the owning statemachine. Completion events are posted with
+               internal priority. Has to be invoked by the executor.
+
+   \param[in]        async    Asynchronous job
+
+   \returns    true if the completion event has been posted. false if the event queue is full.
+               The completion event is kept in the job then, so posting may be retried by
+               sm_async_post() without running the work again.
+
+   \ingroup SmInterface
+*/
+bool sm_async_run(sm_async_t *async)
+{
+   if(!async || !async->work) return false;
+
+   async->event = async->work(async->data);
+
+   return sm_async_post(async);
+}
+
+/*!
+   \brief      Posts the completion event of an asynchronous job
+   \details    Posts the completion event kept in the job to the event queue of the owning
+               statemachine, with internal priority. Meant to retry posting after sm_async_run()
+               failed due to a full event queue. Does not run the work again.
+
+   \param[in]        async    Asynchronous job, run by sm_async_run() before
+
+   \returns    true if the completion event has been posted. false if the event queue is full.
+
+   \ingroup SmInterface
+*/
+bool sm_async_post(sm_async_t *async)
+{
+   if(!async) return false;
+
+   return sm_queue_post(async->queue, SM_QUEUE_PRIO_INTERNAL, async->event, async->data);
+}
@@ -0,0 +1,116 @@
+/*! \copyright
+               Copyright (c) 2013, marco@bacchi.at
+               All rights reserved.
+
+               Redistribution and use in source and binary forms, with or without
+               modification, are permitted provided that the following conditions
+               are met:
+               1. Redistributions of source code must retain the above copyright
+                notice, this list of conditions and the following disclaimer.
+               2. Redistributions in binary form must reproduce the above copyright
+                notice, this list of conditions and the following disclaimer in the
+                documentation and/or other materials provided with the distribution.
+               3. The name of the author may not be used to endorse or promote
+                products derived from this software without specific prior
+                written permission.
+
+               THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS
+               OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+               ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+               DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+               GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+               INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+               WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+               NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+   \file       sm_async.h
+   \version    0000
+   \authors    marco@bacchi.at
+   \date       2013
+
+   \brief      Asynchronous actions for UML state machines - interface
+
+   \details    Long lasting work like disk writes or compression should not be done within
+               entry/exit/transition/effect functions, as it blocks sm_send() and all other
+               statemachines dispatched by the same thread. Instead, such a function submits
+               the work as an asynchronous job and returns immediately. The job is handed over
+               to an executor, e.g. a worker thread pool, which runs the work by calling
+               sm_async_run(). The event returned by the work is posted as completion event
+               with internal priority to the event queue of the owning statemachine, together
+               with the job data.
+               The completion event is dispatched by sm_queue_dispatch() like any other posted event.
+
+               If no executor is installed, the work is run immediately within sm_async_submit().
+               The completion event is posted nevertheless, so the statemachine behaves the same
+               in both cases.
+
+               If the event queue is full, the completion event is kept in the job and its posting
+               may be retried by sm_async_post() without running the work again.
+
+               If sm_async_run() is invoked from another thread than the one dispatching the
+               event queue, SM_QUEUE_LOCK and SM_QUEUE_UNLOCK have to be defined when compiling
+               sm_queue.c (see sm_queue.h).
+
+               __Changelog__
+
+               Revision|Date    |Name  |Change
+               --------|--------|------|-------------------------------------------------
+               0000    |00.00.00|bacmar|Detailed Change Text
+*/
+
+#ifndef SM_ASYNC_H_
+#define SM_ASYNC_H_
+
+#include "sm.h"
+#include "sm_queue.h"
+#include <stdbool.h>
+
+/*!
+   Forward declaration of sm_async structure
+*/
+typedef struct sm_async_t sm_async_t;
+
+/*!
+   \brief      Callback function type for asynchronous work
+   \details    Performs the work of an asynchronous job. It is invoked by the executor, usually
+               on another thread than the statemachine. It must not access the statemachine.
+
+   \param      data     Data associated with the job
+
+   \returns    Completion event to be posted to the owning statemachine
+*/
+typedef event_t(*sm_async_work_fp)(void* data);
+
+/*!
+   \brief      Callback function type for executors
+   \details    Hands over an asynchronous job to e.g. a worker thread pool. The executor has to
+               invoke sm_async_run() for the job as soon as it gets scheduled.
+
+   \param      async    Asynchronous job to be executed
+*/
+typedef void(*sm_async_executor_fp)(sm_async_t *async);
+
+/*!
+    \brief     Asynchronous job declaration
+    \details   Holds the work to be done and the event queue of the owning statemachine.
+               The job has to stay valid until its completion event got posted.
+*/
+struct sm_async_t {
+   sm_async_work_fp work;     /*!< Work to be done */
+   void *data;                /*!< Data associated with the job, forwarded with the completion event */
+   sm_queue_t *queue;         /*!< Event queue of the owning statemachine */
+   event_t event;             /*!< Completion event returned by the work */
+};
+
+extern sm_async_executor_fp sm_async_executor; /*!< global variable for the executor */
+
+bool sm_async_submit(sm_async_t *async, sm_queue_t *queue, sm_async_work_fp work, void *data);
+bool sm_async_run(sm_async_t *async);
+bool sm_async_post(sm_async_t *async);
+
+
+#endif /* SM_ASYNC_H_ */
@@ -0,0 +1,289 @@
+/*! \copyright
+               Copyright (c) 2013, marco@bacchi.at
+               All rights reserved.
+
+               Redistribution and use in source and binary forms, with or without
+               modification, are permitted provided that the following conditions
+               are met:
+               1. Redistributions of source code must retain the above copyright
+                notice, this list of conditions and the following disclaimer.
+               2. Redistributions in binary form must reproduce the above copyright
+                notice, this list of conditions and the following disclaimer in the
+                documentation and/or other materials provided with the distribution.
+               3. The name of the author may not be used to endorse or promote
+                products derived from this software without specific prior
+                written permission.
+
+               THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS
+               OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+               ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+               DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+               GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+               INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+               WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+               NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+   \file       sm_bus.c
+   \version    0000
+   \authors    marco@bacchi.at
+   \date       2013
+
+   \brief      Shared memory event bus for UML state machines - implementation
+
+   \details    Multi-producer/single-consumer ring of fixed size event records. Every record carries
+               a sequence number telling whether it is ready to be posted or to be dispatched at
+               a specific ring position, so producers only contend on the enqueue position and
+               never on the records themselves (D. Vyukov, bounded MPMC queue).
+
+               __Changelog__
+
+               Revision|Date    |Name  |Change
+               --------|--------|------|-------------------------------------------------
+               0000    |00.00.00|bacmar|Detailed Change Text
+*/
+
+#include "sm_bus.h"
+#include <string.h>
+
+/*!
+   \brief      Hook to put the consumer to sleep, NULL to poll instead
+ */
+sm_bus_sleep_fp sm_bus_sleep = NULL;
+
+/*!
+   \brief      Hook to wake up the consumer, NULL if the consumer polls
+ */
+sm_bus_wakeup_fp sm_bus_wakeup = NULL;
+
+
+
+/*!
+   \brief      Checks whether an event is reserved by the statemachine implementation
+   \details    SM_EVENT_INIT, SM_EVENT_EXIT and SM_EVENT_COMPLETION must not be sent by the user,
+               so they are not accepted from other processes either.
+
+   \param[in]        event    Event to be checked
+
+   \returns    true if the event is reserved. false otherwise.
+*/
+static bool sm_bus_reserved(event_t event)
+{
+   return event == SM_EVENT_INIT || event == SM_EVENT_EXIT || event == SM_EVENT_COMPLETION;
+}
+
+/*!
+   \brief      Checks whether there is a record to be dispatched
+   \details    May only be invoked by the consumer.
+
+   \param[in]        bus      Event bus instance
+
+   \returns    true if the ring is empty. false otherwise.
+*/
+static bool sm_bus_empty(sm_bus_t* bus)
+{
+   size_t pos = atomic_load_explicit(&bus->dequeue,memory_order_relaxed);
+   sm_bus_record_t* record = &bus->records[pos & bus->mask];
+
+   return atomic_load_explicit(&record->sequence,memory_order_acquire) != pos + 1;
+}
+
+/*!
+   \brief      Size of an event bus
+   \details    Determines the size of the memory segment required for an event bus.
+
+   \param[in]        records  Number of records of the ring
+
+   \returns    Size of the event bus in bytes
+
+   \ingroup SmInterface
+*/
+size_t sm_bus_bytes(size_t records)
+{
+   return sizeof(sm_bus_t) + records * sizeof(sm_bus_record_t);
+}
+
+/*!
+   \brief      Initialize an event bus
+   \details    Initializes an empty event bus within the provided memory segment. Has to be invoked
+               once, before any process posts or dispatches records.
+
+   \param[out]       bus      Event bus instance, of at least sm_bus_bytes(records) bytes
+   \param[in]        records  Number of records of the ring, has to be a power of two
+
+   \returns    true if the bus has been initialized. false if the arguments are invalid.
+
+   \ingroup SmInterface
+*/
+bool sm_bus_init(sm_bus_t* bus, size_t records)
+{
+   size_t pos;
+
+   if(!bus || records < 2 || (records & (records - 1))) return false;
+
+   bus->mask = records - 1;
+   atomic_init(&bus->enqueue,0);
+   atomic_init(&bus->dequeue,0);
+   atomic_init(&bus->sleeping,0);
+
+   /* every record is ready to be posted at its own ring position */
+   for(pos = 0; pos < records; pos++)
+      atomic_init(&bus->records[pos].sequence,pos);
+
+   return true;
+}
+
+/*!
+   \brief      Posts an event to an event bus
+   \details    Copies the event and its payload into the next free record. May be invoked
+               concurrently by any number of threads and processes. Wakes up the consumer,
+               if it is sleeping.
+
+   \param[in,out]    bus      Event bus instance
+   \param[in]        instance Index of the target statemachine instance of the consumer
+   \param[in]        event    Event to be posted
+   \param[in]        payload  Payload associated with the event, copied into the record
+   \param[in]        size     Size of the payload in bytes, at most SM_BUS_PAYLOAD_SIZE
+
+   \returns    true if the event has been posted. false if the ring is full, the payload too big
+               or the event is reserved (SM_EVENT_INIT, SM_EVENT_EXIT, SM_EVENT_COMPLETION).
+
+   \ingroup SmInterface
+*/
+bool sm_bus_post(sm_bus_t* bus, unsigned int instance, event_t event, const void* payload, size_t size)
+{
+   sm_bus_record_t* record;
+   size_t pos;
+   size_t sequence;
+
+   if(!bus || size > SM_BUS_PAYLOAD_SIZE || (size && !payload) || sm_bus_reserved(event)) return false;
+
+   /* claim ring position */
+   pos = atomic_load_explicit(&bus->enqueue,memory_order_relaxed);
+
+   for(;;)
+   {
+      record = &bus->records[pos & bus->mask];
+      sequence = atomic_load_explicit(&record->sequence,memory_order_acquire);
+
+      if(sequence == pos)
+      {
+         if(atomic_compare_exchange_weak_explicit(&bus->enqueue,&pos,pos + 1,
+               memory_order_relaxed,memory_order_relaxed))
+            break;
+      }
+      else if((ptrdiff_t)(sequence - pos) < 0)
+      {
+         /* record of the previous round not dispatched yet */
+         return false;
+      }
+      else
+      {
+         pos = atomic_load_explicit(&bus->enqueue,memory_order_relaxed);
+      }
+   }
+
+   /* fill record and hand it over to the consumer */
+   record->instance = instance;
+   record->event = event;
+   record->size = size;
+   if(size)
+      memcpy(record->payload,payload,size);
+
+   atomic_store_explicit(&record->sequence,pos + 1,memory_order_release);
+
+   /* wake up consumer, if sleeping */
+   atomic_thread_fence(memory_order_seq_cst);
+
+   if(atomic_load_explicit(&bus->sleeping,memory_order_relaxed)
+         && atomic_exchange(&bus->sleeping,0) && sm_bus_wakeup)
+      sm_bus_wakeup(&bus->sleeping);
+
+   return true;
+}
+
+/*!
+   \brief      Dispatches posted events to the statemachines
+   \details    Sends up to max posted events in ring order to the target statemachines. The event
+               data is a pointer to a copy of the inline payload, aligned for any type and valid
+               during sm_send() only, or NULL if the payload is empty. The payload size is not
+               passed on, the statemachine has to derive it from the event.
+               Records addressing an instance out of range or carrying a reserved event
+               (SM_EVENT_INIT, SM_EVENT_EXIT, SM_EVENT_COMPLETION) are dropped. May only be invoked
+               by the single consumer.
+
+   \param[in,out]    bus         Event bus instance
+   \param[in,out]    instances   Statemachine instances addressed by the records
+   \param[in]        count       Number of statemachine instances
+   \param[in]        max         Maximum number of events to be dispatched
+
+   \returns    Number of dequeued records, including dropped ones
+
+   \ingroup SmInterface
+*/
+size_t sm_bus_dispatch(sm_bus_t* bus, sm_t* instances, size_t count, size_t max)
+{
+   sm_bus_record_t* record;
+   _Alignas(max_align_t) unsigned char payload[SM_BUS_PAYLOAD_SIZE];
+   unsigned int instance;
+   event_t event;
+   size_t size;
+   size_t pos;
+   size_t dispatched = 0;
+
+   if(!bus || !instances) return 0;
+
+   pos = atomic_load_explicit(&bus->dequeue,memory_order_relaxed);
+
+   while(dispatched < max)
+   {
+      record = &bus->records[pos & bus->mask];
+
+      if(atomic_load_explicit(&record->sequence,memory_order_acquire) != pos + 1)
+         break;
+
+      /* copy record and release it to the producers */
+      instance = record->instance;
+      event = record->event;
+      size = record->size < SM_BUS_PAYLOAD_SIZE ? record->size : SM_BUS_PAYLOAD_SIZE;
+      memcpy(payload,record->payload,size);
+
+      atomic_store_explicit(&record->sequence,pos + bus->mask + 1,memory_order_release);
+      atomic_store_explicit(&bus->dequeue,++pos,memory_order_relaxed);
+
+      if(instance < count && !sm_bus_reserved(event))
+         sm_send(&instances[instance],event,size ? payload : NULL);
+
+      dispatched++;
+   }
+
+   return dispatched;
+}
+
+/*!
+   \brief      Waits for posted events
+   \details    Puts the consumer to sleep by the sm_bus_sleep hook, as long as the ring is empty.
+               Returns immediately if no hook is installed. May only be invoked by the consumer.
+
+   \param[in,out]    bus      Event bus instance
+
+   \ingroup SmInterface
+*/
+void sm_bus_wait(sm_bus_t* bus)
+{
+   if(!bus) return;
+
+   atomic_store(&bus->sleeping,1);
+
+   /* order the announcement before the recheck, pairs with the fence of sm_bus_post() */
+   atomic_thread_fence(memory_order_seq_cst);
+
+   /* recheck after announcing sleep, a producer may have posted in between */
+   if(sm_bus_empty(bus) && sm_bus_sleep)
+      sm_bus_sleep(&bus->sleeping,1);
+
+   atomic_store(&bus->sleeping,0);
+}
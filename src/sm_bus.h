@@ -0,0 +1,145 @@
+/*! \copyright
+               Copyright (c) 2013, marco@bacchi.at
+               All rights reserved.
+
+               Redistribution and use in source and binary forms, with or without
+               modification, are permitted provided that the following conditions
+               are met:
+               1. Redistributions of source code must retain the above copyright
+                notice, this list of conditions and the following disclaimer.
+               2. Redistributions in binary form must reproduce the above copyright
+                notice, this list of conditions and the following disclaimer in the
+                documentation and/or other materials provided with the distribution.
+               3. The name of the author may not be used to endorse or promote
+                products derived from this software without specific prior
+                written permission.
+
+               THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS
+               OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+               ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+               DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+               GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+               INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+               WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+               NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+   \file       sm_bus.h
+   \version    0000
+   \authors    marco@bacchi.at
+   \date       2013
+
+   \brief      Shared memory event bus for UML state machines - interface
+
+   \details    The event bus transports events from other processes to the statemachines of a
+               consumer process without system calls or copies through the kernel. It is a
+               multi-producer/single-consumer ring of fixed size records, each holding the index
+               of the target statemachine instance, the event and an inline payload of up to
+               SM_BUS_PAYLOAD_SIZE bytes. The bus contains no pointers, so it can be placed in
+               a memory segment shared between processes (e.g. memfd or POSIX shm), mapped at
+               any address. All processes have to be built with the same SM_BUS_PAYLOAD_SIZE.
+
+               Producers post records by sm_bus_post(). The consumer dispatches them in batches
+               to its statemachines by sm_bus_dispatch(), which invokes sm_send() with a pointer to
+               a copy of the inline payload as event data, or NULL if the payload is empty. The copy
+               is suitably aligned for any type. The size of the payload is not passed on, so the
+               statemachine has to derive it from the event. Events to a statemachine are dispatched
+               in the order they have been posted.
+
+               The bus itself does not block. If the ring is empty, the consumer may go to sleep
+               by sm_bus_wait(), which uses the sm_bus_sleep/sm_bus_wakeup hooks. On Linux they are
+               meant to be mapped to FUTEX_WAIT/FUTEX_WAKE on the provided word. Producers only
+               invoke sm_bus_wakeup if the consumer is actually sleeping, so there is no system
+               call as long as the consumer is busy.
+
+               Records carrying a reserved event (SM_EVENT_INIT, SM_EVENT_EXIT, SM_EVENT_COMPLETION)
+               are rejected by sm_bus_post() and dropped by sm_bus_dispatch(), so other processes
+               cannot fake initialization, termination or completion transitions.
+
+               All processes attached to the bus have to be trusted and reliable. A producer that
+               dies after claiming a record but before handing it over leaves that record unfinished
+               forever. The consumer stops at it, and once the ring wraps around every further post
+               fails. There is no recovery within the bus. If producers may crash, the supervisor
+               has to detect this (e.g. by sm_bus_post() failing persistently while the consumer
+               is idle) and recreate the bus by sm_bus_init() after all processes detached from it.
+
+               Requires C11 lock-free atomics.
+
+               __Changelog__
+
+               Revision|Date    |Name  |Change
+               --------|--------|------|-------------------------------------------------
+               0000    |00.00.00|bacmar|Detailed Change Text
+*/
+
+#ifndef SM_BUS_H_
+#define SM_BUS_H_
+
+#include "sm.h"
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifndef SM_BUS_PAYLOAD_SIZE
+/*! Maximum size of the inline payload of an event record in bytes */
+#define SM_BUS_PAYLOAD_SIZE 32
+#endif
+
+/*!
+   \brief      Callback function type to put the consumer to sleep
+   \details    Blocks the calling thread as long as the word holds the expected value.
+               May return spuriously. Usually mapped to FUTEX_WAIT.
+
+   \param      word     Shared word to wait on
+   \param      expected Value of the word to block on
+*/
+typedef void(*sm_bus_sleep_fp)(atomic_uint* word, unsigned int expected);
+
+/*!
+   \brief      Callback function type to wake up the consumer
+   \details    Wakes up the thread sleeping on the word. Usually mapped to FUTEX_WAKE.
+
+   \param      word     Shared word the consumer is sleeping on
+*/
+typedef void(*sm_bus_wakeup_fp)(atomic_uint* word);
+
+/*!
+    \brief     Event record declaration
+    \details   Fixed size slot of the ring.
+*/
+typedef struct {
+   atomic_size_t sequence;                      /*!< Ring position the record is ready for */
+   unsigned int instance;                       /*!< Index of the target statemachine instance */
+   event_t event;                               /*!< Posted event */
+   size_t size;                                 /*!< Size of the inline payload in bytes */
+   _Alignas(max_align_t) unsigned char payload[SM_BUS_PAYLOAD_SIZE];  /*!< Inline payload, aligned for any type */
+}sm_bus_record_t;
+
+/*!
+    \brief     Event bus declaration
+    \details   Header of the ring, followed by its records. Use sm_bus_bytes() to determine
+               the size of the memory segment required.
+*/
+typedef struct {
+   size_t mask;                  /*!< Number of records - 1, the number of records is a power of two */
+   atomic_size_t enqueue;        /*!< Next ring position to be posted by producers */
+   atomic_size_t dequeue;        /*!< Next ring position to be dispatched by the consumer */
+   atomic_uint sleeping;         /*!< Nonzero while the consumer is sleeping or about to */
+   sm_bus_record_t records[];    /*!< Records of the ring */
+}sm_bus_t;
+
+
+extern sm_bus_sleep_fp sm_bus_sleep;      /*!< global variable for the sleep hook of the consumer */
+extern sm_bus_wakeup_fp sm_bus_wakeup;    /*!< global variable for the wakeup hook of the producers */
+
+size_t sm_bus_bytes(size_t records);
+bool sm_bus_init(sm_bus_t* bus, size_t records);
+bool sm_bus_post(sm_bus_t* bus, unsigned int instance, event_t event, const void* payload, size_t size);
+size_t sm_bus_dispatch(sm_bus_t* bus, sm_t* instances, size_t count, size_t max);
+void sm_bus_wait(sm_bus_t* bus);
+
+
+#endif /* SM_BUS_H_ */
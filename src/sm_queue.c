@@ -0,0 +1,243 @@
+/*! \copyright
+               Copyright (c) 2013, marco@bacchi.at
+               All rights reserved.
+
+               Redistribution and use in source and binary forms, with or without
+               modification, are permitted provided that the following conditions
+               are met:
+               1. Redistributions of source code must retain the above copyright
+                notice, this list of conditions and the following disclaimer.
+               2. Redistributions in binary form must reproduce the above copyright
+                notice, this list of conditions and the following disclaimer in the
+                documentation and/or other materials provided with the distribution.
+               3. The name of the author may not be used to endorse or promote
+                products derived from this software without specific prior
+                written permission.
+
+               THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS
+               OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+               ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+               DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+               GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+               INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+               WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+               NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+   \file       sm_queue.c
+   \version    0000
+   \authors    marco@bacchi.at
+   \date       2013
+
+   \brief      Event queue for UML state machines - implementation
+
+   \details    Events must not be sent to a statemachine from within its own entry/exit/transition/effect
+               functions (due to recursion). The event queue allows such functions, or any other producer
+               like an asynchronous job (see sm_async.h), to post events instead. Posted events are
+               dispatched by priority class and in FIFO order within a priority class to the
+               statemachine by calling sm_queue_dispatch() from the outer loop, after sm_send()
+               has returned.
+
+               __Changelog__
+
+               Revision|Date    |Name  |Change
+               --------|--------|------|-------------------------------------------------
+               0000    |00.00.00|bacmar|Detailed Change Text
+*/
+
+#include "sm_queue.h"
+
+
+/*!
+   \brief      Selects the FIFO to dispatch the next event from
+   \details    Selects the non-empty FIFO of highest priority, unless a FIFO of lower priority
+               has reached the starvation limit. Updates the starvation counters of all FIFOs
+               passed over. Has to be invoked with the queue locked.
+
+   \param[in,out]    queue    Event queue instance
+
+   \returns    Priority class of the selected FIFO. SM_QUEUE_PRIO_COUNT if the queue is empty.
+*/
+static sm_queue_prio_t sm_queue_select(sm_queue_t *queue)
+{
+   sm_queue_prio_t prio;
+   sm_queue_prio_t selected = SM_QUEUE_PRIO_COUNT;
+
+   /* starving FIFO of highest priority, if any */
+   for(prio = 0; prio < SM_QUEUE_PRIO_COUNT; prio++)
+   {
+      if(queue->fifos[prio].count && queue->fifos[prio].skipped >= SM_QUEUE_STARVATION_LIMIT)
+      {
+         selected = prio;
+         break;
+      }
+   }
+
+   /* otherwise non-empty FIFO of highest priority, if any */
+   if(selected == SM_QUEUE_PRIO_COUNT)
+   {
+      for(prio = 0; prio < SM_QUEUE_PRIO_COUNT; prio++)
+      {
+         if(queue->fifos[prio].count)
+         {
+            selected = prio;
+            break;
+         }
+      }
+   }
+
+   /* age all other pending FIFOs */
+   for(prio = 0; prio < SM_QUEUE_PRIO_COUNT; prio++)
+   {
+      if(prio == selected)
+         queue->fifos[prio].skipped = 0;
+      else if(queue->fifos[prio].count)
+         queue->fifos[prio].skipped++;
+   }
+
+   return selected;
+}
+
+/*!
+   \brief      Initialize an event queue
+   \details    Initializes an empty event queue without storage. Storage has to be provided
+               by sm_queue_setup() for every priority class in use.
+
+   \param[out]       queue    Event queue instance
+
+   \ingroup SmInterface
+*/
+void sm_queue_init(sm_queue_t *queue)
+{
+   sm_queue_prio_t prio;
+
+   if(!queue) return;
+
+   for(prio = 0; prio < SM_QUEUE_PRIO_COUNT; prio++)
+      sm_queue_setup(queue, prio, NULL, 0);
+}
+
+/*!
+   \brief      Provides storage for a priority class of an event queue
+   \details    Assigns the storage to the FIFO of the priority class. Any events posted to
+               that FIFO before are discarded.
+
+   \param[in,out]    queue    Event queue instance
+   \param[in]        prio     Priority class
+   \param[in]        entries  Storage for posted events
+   \param[in]        size     Number of entries of the storage
+
+   \ingroup SmInterface
+*/
+void sm_queue_setup(sm_queue_t *queue, sm_queue_prio_t prio, sm_queue_entry_t *entries, size_t size)
+{
+   sm_queue_fifo_t *fifo;
+
+   if(!queue || prio >= SM_QUEUE_PRIO_COUNT) return;
+
+   fifo = &queue->fifos[prio];
+
+   SM_QUEUE_LOCK();
+
+   fifo->entries = entries;
+   fifo->size = entries ? size : 0;
+   fifo->head = 0;
+   fifo->count = 0;
+   fifo->skipped = 0;
+
+   SM_QUEUE_UNLOCK();
+}
+
+/*!
+   \brief      Posts an event to an event queue
+   \details    Appends an event to the FIFO of the given priority class. In contrast to sm_send()
+               this function may be invoked from within entry/exit/transition/effect functions.
+
+   \param[in,out]    queue    Event queue instance
+   \param[in]        prio     Priority class of the event
+   \param[in]        event    Event to be posted
+   \param[in]        data     Data associated with the event. Has to stay valid until the event
+                              got dispatched.
+
+   \returns    true if the event has been posted. false if the FIFO is full or has no storage.
+
+   \ingroup SmInterface
+*/
+bool sm_queue_post(sm_queue_t *queue, sm_queue_prio_t prio, event_t event, void *data)
+{
+   sm_queue_fifo_t *fifo;
+   sm_queue_entry_t *entry;
+
+   if(!queue || prio >= SM_QUEUE_PRIO_COUNT) return false;
+
+   fifo = &queue->fifos[prio];
+
+   SM_QUEUE_LOCK();
+
+   if(fifo->count >= fifo->size)
+   {
+      SM_QUEUE_UNLOCK();
+      return false;
+   }
+
+   entry = &fifo->entries[(fifo->head + fifo->count) % fifo->size];
+   entry->event = event;
+   entry->data = data;
+   fifo->count++;
+
+   SM_QUEUE_UNLOCK();
+
+   return true;
+}
+
+/*!
+   \brief      Dispatches all posted events to a statemachine
+   \details    Sends the posted events to the statemachine until the queue is empty. Events of
+               higher priority classes are dispatched first, events of the same priority class
+               in FIFO order. Events posted while dispatching are dispatched within the same call.
+               Must not be invoked from within entry/exit/transition/effect functions.
+
+   \param[in,out]    sm       State machine instance
+   \param[in,out]    queue    Event queue instance
+
+   \returns    Number of dispatched events
+
+   \ingroup SmInterface
+*/
+size_t sm_queue_dispatch(sm_t *sm, sm_queue_t *queue)
+{
+   sm_queue_fifo_t *fifo;
+   sm_queue_entry_t entry;
+   sm_queue_prio_t prio;
+   size_t dispatched = 0;
+
+   if(!sm || !queue) return 0;
+
+   for(;;)
+   {
+      SM_QUEUE_LOCK();
+
+      prio = sm_queue_select(queue);
+
+      if(prio == SM_QUEUE_PRIO_COUNT)
+      {
+         SM_QUEUE_UNLOCK();
+         break;
+      }
+
+      fifo = &queue->fifos[prio];
+      entry = fifo->entries[fifo->head];
+      fifo->head = (fifo->head + 1) % fifo->size;
+      fifo->count--;
+
+      SM_QUEUE_UNLOCK();
+
+      sm_send(sm, entry.event, entry.data);
+      dispatched++;
+   }
+
+   return dispatched;
+}
@@ -0,0 +1,136 @@
+/*! \copyright
+               Copyright (c) 2013, marco@bacchi.at
+               All rights reserved.
+
+               Redistribution and use in source and binary forms, with or without
+               modification, are permitted provided that the following conditions
+               are met:
+               1. Redistributions of source code must retain the above copyright
+                notice, this list of conditions and the following disclaimer.
+               2. Redistributions in binary form must reproduce the above copyright
+                notice, this list of conditions and the following disclaimer in the
+                documentation and/or other materials provided with the distribution.
+               3. The name of the author may not be used to endorse or promote
+                products derived from this software without specific prior
+                written permission.
+
+               THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS
+               OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+               ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+               DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+               GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+               INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+               WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+               NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+   \file       sm_queue.h
+   \version    0000
+   \authors    marco@bacchi.at
+   \date       2013
+
+   \brief      Event queue for UML state machines - interface
+
+   \details    Events must not be sent to a statemachine from within its own entry/exit/transition/effect
+               functions (due to recursion). The event queue allows such functions, or any other producer
+               like an asynchronous job (see sm_async.h), to post events instead. Posted events are
+               dispatched to the statemachine by calling sm_queue_dispatch() from the outer loop,
+               after sm_send() has returned.
+
+               Every event is posted with a priority class. Each priority class has its own FIFO,
+               so urgent events do not wait behind a backlog of routine events. The FIFOs are
+               serviced in priority order. To bound starvation, a pending event of a lower priority
+               class gets dispatched after it has been passed over SM_QUEUE_STARVATION_LIMIT
+               times in a row.
+
+               The queue does not allocate memory. Its storage has to be provided by the user
+               for each priority class in use.
+
+               The queue is not interrupt/thread safe by itself. If events are posted from another
+               context than the one dispatching them, define SM_QUEUE_LOCK and SM_QUEUE_UNLOCK
+               to the appropriate locking primitives of the target (e.g. disable/enable interrupts
+               or lock/unlock a mutex). The hooks are expanded within sm_queue.c only, so they have
+               to be defined when compiling sm_queue.c, e.g. by -D options or a configuration header
+               included via -include. Defining them in a file including this header has no effect.
+               The same applies to SM_QUEUE_STARVATION_LIMIT.
+
+               __Changelog__
+
+               Revision|Date    |Name  |Change
+               --------|--------|------|-------------------------------------------------
+               0000    |00.00.00|bacmar|Detailed Change Text
+*/
+
+#ifndef SM_QUEUE_H_
+#define SM_QUEUE_H_
+
+#include "sm.h"
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifndef SM_QUEUE_LOCK
+/*! Enter critical section protecting the queue, empty by default. Has to be defined when compiling sm_queue.c */
+#define SM_QUEUE_LOCK()
+#endif
+
+#ifndef SM_QUEUE_UNLOCK
+/*! Leave critical section protecting the queue, empty by default. Has to be defined when compiling sm_queue.c */
+#define SM_QUEUE_UNLOCK()
+#endif
+
+#ifndef SM_QUEUE_STARVATION_LIMIT
+/*! Number of times a pending event may be passed over by events of higher priority classes */
+#define SM_QUEUE_STARVATION_LIMIT 16
+#endif
+
+/*!
+    \brief     Enumeration of event priority classes
+    \details   Ordered from highest to lowest priority.
+*/
+typedef enum {
+   SM_QUEUE_PRIO_INTERNAL,    /*!< Internal events, e.g. completion events of asynchronous jobs */
+   SM_QUEUE_PRIO_HIGH,        /*!< Urgent events, e.g. shutdown or error events */
+   SM_QUEUE_PRIO_NORMAL,      /*!< Routine events */
+   SM_QUEUE_PRIO_COUNT        /*!< Number of priority classes */
+}sm_queue_prio_t;
+
+/*!
+    \brief     Event queue entry
+    \details   Holds a posted event and the data associated with it.
+*/
+typedef struct {
+   event_t event;          /*!< Posted event */
+   void *data;             /*!< Data associated with the event */
+}sm_queue_entry_t;
+
+/*!
+    \brief     Event FIFO declaration
+    \details   Ring buffer of posted events of one priority class. The entries are provided by the user.
+*/
+typedef struct {
+   sm_queue_entry_t *entries; /*!< Storage for posted events */
+   size_t size;               /*!< Number of entries of the storage */
+   size_t head;               /*!< Index of the oldest posted event */
+   size_t count;              /*!< Number of posted events */
+   unsigned int skipped;      /*!< Number of times the oldest posted event has been passed over */
+}sm_queue_fifo_t;
+
+/*!
+    \brief     Event queue declaration
+    \details   Holds one FIFO per priority class.
+*/
+typedef struct {
+   sm_queue_fifo_t fifos[SM_QUEUE_PRIO_COUNT];  /*!< FIFOs indexed by priority class */
+}sm_queue_t;
+
+
+void sm_queue_init(sm_queue_t *queue);
+void sm_queue_setup(sm_queue_t *queue, sm_queue_prio_t prio, sm_queue_entry_t *entries, size_t size);
+bool sm_queue_post(sm_queue_t *queue, sm_queue_prio_t prio, event_t event, void *data);
+size_t sm_queue_dispatch(sm_t *sm, sm_queue_t *queue);
+
+
+#endif /* SM_QUEUE_H_ */
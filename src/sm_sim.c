@@ -0,0 +1,351 @@
+/*! \copyright
+               Copyright (c) 2013, marco@bacchi.at
+               All rights reserved.
+
+               Redistribution and use in source and binary forms, with or without
+               modification, are permitted provided that the following conditions
+               are met:
+               1. Redistributions of source code must retain the above copyright
+                notice, this list of conditions and the following disclaimer.
+               2. Redistributions in binary form must reproduce the above copyright
+                notice, this list of conditions and the following disclaimer in the
+                documentation and/or other materials provided with the distribution.
+               3. The name of the author may not be used to endorse or promote
+                products derived from this software without specific prior
+                written permission.
+
+               THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS
+               OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+               ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+               DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+               GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+               INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+               WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+               NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+   \file       sm_sim.c
+   \version    0000
+   \authors    marco@bacchi.at
+   \date       2013
+
+   \brief      Timed event scheduler and simulation driver for UML state machines - implementation
+
+   \details    Pending timed events are kept in a binary heap ordered by due time and sequence
+               number. Without a clock, time jumps straight to the next pending event.
+
+               __Changelog__
+
+               Revision|Date    |Name  |Change
+               --------|--------|------|-------------------------------------------------
+               0000    |00.00.00|bacmar|Detailed Change Text
+*/
+
+#include "sm_sim.h"
+
+/*! Seed used instead of zero, which would stall the random number generator */
+#define SM_SIM_SEED_DEFAULT 0x9E3779B97F4A7C15ULL
+
+
+/*!
+   \brief      Compares the order of two timed events
+   \details    Events are ordered by due time, events due at the same point in time by sequence number.
+
+   \param[in]        a        Timed event
+   \param[in]        b        Timed event
+
+   \returns    true if a is due before b. false otherwise.
+*/
+static bool sm_sim_before(const sm_sim_event_t *a, const sm_sim_event_t *b)
+{
+   if(a->time != b->time)
+      return a->time < b->time;
+
+   return a->sequence < b->sequence;
+}
+
+/*!
+   \brief      Moves a timed event of the heap towards the root
+   \details    Restores the heap order after the event at index has been inserted or moved.
+
+   \param[in,out]    sim      Scheduler instance
+   \param[in]        index    Heap index of the event
+*/
+static void sm_sim_sift_up(sm_sim_t *sim, size_t index)
+{
+   sm_sim_event_t event = sim->events[index];
+   size_t parent;
+
+   while(index)
+   {
+      parent = (index - 1) / 2;
+
+      if(!sm_sim_before(&event,&sim->events[parent]))
+         break;
+
+      sim->events[index] = sim->events[parent];
+      index = parent;
+   }
+
+   sim->events[index] = event;
+}
+
+/*!
+   \brief      Moves a timed event of the heap towards the leaves
+   \details    Restores the heap order after the event at index has been replaced.
+
+   \param[in,out]    sim      Scheduler instance
+   \param[in]        index    Heap index of the event
+*/
+static void sm_sim_sift_down(sm_sim_t *sim, size_t index)
+{
+   sm_sim_event_t event = sim->events[index];
+   size_t child;
+
+   while((child = 2 * index + 1) < sim->count)
+   {
+      if(child + 1 < sim->count && sm_sim_before(&sim->events[child + 1],&sim->events[child]))
+         child++;
+
+      if(!sm_sim_before(&sim->events[child],&event))
+         break;
+
+      sim->events[index] = sim->events[child];
+      index = child;
+   }
+
+   sim->events[index] = event;
+}
+
+/*!
+   \brief      Removes a timed event from the heap
+
+   \param[in,out]    sim      Scheduler instance
+   \param[in]        index    Heap index of the event
+*/
+static void sm_sim_remove(sm_sim_t *sim, size_t index)
+{
+   sim->count--;
+
+   if(index == sim->count)
+      return;
+
+   sim->events[index] = sim->events[sim->count];
+   sm_sim_sift_down(sim,index);
+   sm_sim_sift_up(sim,index);
+}
+
+/*!
+   \brief      Initialize a scheduler
+   \details    Initializes a scheduler running in virtual time, starting at time 0,
+               without pending events.
+
+   \param[out]       sim      Scheduler instance
+   \param[in]        events   Storage for pending events
+   \param[in]        size     Number of entries of the storage
+   \param[in]        seed     Seed of the random number generator
+
+   \ingroup SmInterface
+*/
+void sm_sim_init(sm_sim_t *sim, sm_sim_event_t *events, size_t size, unsigned long long seed)
+{
+   if(!sim) return;
+
+   sim->events = events;
+   sim->size = events ? size : 0;
+   sim->count = 0;
+   sim->sequence = 0;
+   sim->now = 0;
+   sim->random = seed ? seed : SM_SIM_SEED_DEFAULT;
+   sim->clock = NULL;
+   sim->context = NULL;
+}
+
+/*!
+   \brief      Installs a clock
+   \details    Time is read from the clock from now on, instead of jumping in virtual time.
+
+   \param[in,out]    sim      Scheduler instance
+   \param[in]        clock    Clock to read time from, NULL for virtual time
+   \param[in]        context  Context of the clock
+
+   \ingroup SmInterface
+*/
+void sm_sim_clock(sm_sim_t *sim, sm_clock_fp clock, void *context)
+{
+   if(!sim) return;
+
+   sim->clock = clock;
+   sim->context = context;
+}
+
+/*!
+   \brief      Current time of a scheduler
+
+   \param[in]        sim      Scheduler instance
+
+   \returns    Current point in time, read from the clock if installed
+
+   \ingroup SmInterface
+*/
+sm_time_t sm_sim_now(sm_sim_t *sim)
+{
+   if(!sim) return 0;
+
+   if(sim->clock)
+      sim->now = sim->clock(sim->context);
+
+   return sim->now;
+}
+
+/*!
+   \brief      Draws a random number
+   \details    Pseudo random number generator (xorshift64*), deterministic for the seed of the
+               scheduler. Meant to generate simulated traffic reproducibly.
+
+   \param[in,out]    sim      Scheduler instance
+
+   \returns    Random number
+
+   \ingroup SmInterface
+*/
+unsigned long sm_sim_random(sm_sim_t *sim)
+{
+   unsigned long long x;
+
+   if(!sim) return 0;
+
+   x = sim->random;
+   x ^= x >> 12;
+   x ^= x << 25;
+   x ^= x >> 27;
+   sim->random = x;
+
+   return (unsigned long)((x * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+/*!
+   \brief      Schedules a timed event
+   \details    The event is dispatched to the statemachine by sm_sim_run() once it is due. May be
+               invoked from within entry/exit/transition/effect functions, e.g. to start a timeout.
+
+   \param[in,out]    sim      Scheduler instance
+   \param[in]        delay    Time from now until the event is due
+   \param[in,out]    sm       Target statemachine
+   \param[in]        event    Event to be scheduled
+   \param[in]        data     Data associated with the event. Has to stay valid until the event
+                              got dispatched or cancelled.
+
+   \returns    true if the event has been scheduled. false if the storage is full.
+
+   \ingroup SmInterface
+*/
+bool sm_sim_schedule(sm_sim_t *sim, sm_time_t delay, sm_t *sm, event_t event, void *data)
+{
+   sm_sim_event_t *entry;
+   sm_time_t now;
+
+   if(!sim || !sm || sim->count >= sim->size) return false;
+
+   now = sm_sim_now(sim);
+
+   entry = &sim->events[sim->count];
+   entry->time = delay < SM_TIME_FOREVER - now ? now + delay : SM_TIME_FOREVER;
+   entry->sequence = sim->sequence++;
+   entry->sm = sm;
+   entry->event = event;
+   entry->data = data;
+
+   sm_sim_sift_up(sim,sim->count++);
+
+   return true;
+}
+
+/*!
+   \brief      Cancels timed events
+   \details    Removes all pending occurrences of the event for the statemachine, e.g. to stop
+               a timeout in an exit action.
+
+   \param[in,out]    sim      Scheduler instance
+   \param[in]        sm       Target statemachine
+   \param[in]        event    Scheduled event
+
+   \returns    Number of cancelled events
+
+   \ingroup SmInterface
+*/
+size_t sm_sim_cancel(sm_sim_t *sim, sm_t *sm, event_t event)
+{
+   size_t index;
+   size_t kept = 0;
+   size_t cancelled;
+
+   if(!sim) return 0;
+
+   /* keep all other events */
+   for(index = 0; index < sim->count; index++)
+   {
+      if(sim->events[index].sm != sm || sim->events[index].event != event)
+         sim->events[kept++] = sim->events[index];
+   }
+
+   cancelled = sim->count - kept;
+   sim->count = kept;
+
+   /* restore heap order */
+   if(cancelled)
+   {
+      for(index = kept / 2; index-- > 0; )
+         sm_sim_sift_down(sim,index);
+   }
+
+   return cancelled;
+}
+
+/*!
+   \brief      Dispatches due timed events
+   \details    Sends the pending events due until the given point in time to their statemachines,
+               in order of due time and, at the same point in time, in order of scheduling.
+               Events scheduled while dispatching are dispatched within the same call, if due.
+               In virtual time, the current time jumps to each event before it is dispatched and
+               finally to until, unless until is SM_TIME_FOREVER. With a clock installed, only
+               events due by the current time of the clock are dispatched.
+               Must not be invoked from within entry/exit/transition/effect functions.
+
+   \param[in,out]    sim      Scheduler instance
+   \param[in]        until    Point in time to run the simulation until
+
+   \returns    Number of dispatched events
+
+   \ingroup SmInterface
+*/
+size_t sm_sim_run(sm_sim_t *sim, sm_time_t until)
+{
+   sm_sim_event_t event;
+   size_t dispatched = 0;
+
+   if(!sim) return 0;
+
+   if(sim->clock && until > sm_sim_now(sim))
+      until = sim->now;
+
+   while(sim->count && sim->events[0].time <= until)
+   {
+      event = sim->events[0];
+      sm_sim_remove(sim,0);
+
+      if(!sim->clock && event.time > sim->now)
+         sim->now = event.time;
+
+      sm_send(event.sm,event.event,event.data);
+      dispatched++;
+   }
+
+   if(!sim->clock && until != SM_TIME_FOREVER && until > sim->now)
+      sim->now = until;
+
+   return dispatched;
+}
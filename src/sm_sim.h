@@ -0,0 +1,124 @@
+/*! \copyright
+               Copyright (c) 2013, marco@bacchi.at
+               All rights reserved.
+
+               Redistribution and use in source and binary forms, with or without
+               modification, are permitted provided that the following conditions
+               are met:
+               1. Redistributions of source code must retain the above copyright
+                notice, this list of conditions and the following disclaimer.
+               2. Redistributions in binary form must reproduce the above copyright
+                notice, this list of conditions and the following disclaimer in the
+                documentation and/or other materials provided with the distribution.
+               3. The name of the author may not be used to endorse or promote
+                products derived from this software without specific prior
+                written permission.
+
+               THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS
+               OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+               ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+               DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+               GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+               INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+               WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+               NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+   \file       sm_sim.h
+   \version    0000
+   \authors    marco@bacchi.at
+   \date       2013
+
+   \brief      Timed event scheduler and simulation driver for UML state machines - interface
+
+   \details    The scheduler dispatches events, e.g. timeouts or simulated traffic, to statemachines
+               at given points in time. Timed events are scheduled by sm_sim_schedule(), which may be
+               invoked from within entry/exit/transition/effect functions, and dispatched by sm_sim_run().
+
+               Without a clock, the scheduler runs in virtual time: time does not pass by itself,
+               but jumps straight to the next pending event. Days of simulated traffic are thereby
+               dispatched as fast as the statemachines can process them. Events of the same point
+               in time are dispatched in the order they have been scheduled, and random numbers are
+               drawn from a generator seeded per scheduler, so a simulation is deterministic for a
+               given seed. Independent schedulers share no data, so simulations may run in parallel
+               on several threads.
+
+               With a clock installed by sm_sim_clock(), e.g. a wall clock, time is read from the
+               clock and sm_sim_run() only dispatches the events that are due.
+
+               The scheduler does not allocate memory. Its storage has to be provided by the user.
+
+               __Changelog__
+
+               Revision|Date    |Name  |Change
+               --------|--------|------|-------------------------------------------------
+               0000    |00.00.00|bacmar|Detailed Change Text
+*/
+
+#ifndef SM_SIM_H_
+#define SM_SIM_H_
+
+#include "sm.h"
+#include <stddef.h>
+#include <stdbool.h>
+
+/*!
+   Point in time or duration, in ticks of the clock
+*/
+typedef unsigned long long sm_time_t;
+
+/*! Point in time after all others, to run a simulation until no events are pending */
+#define SM_TIME_FOREVER (~((sm_time_t)0))
+
+/*!
+   \brief      Callback function type for clocks
+   \details    Reads the current time of the clock.
+
+   \param      context  Context of the clock
+
+   \returns    Current point in time
+*/
+typedef sm_time_t(*sm_clock_fp)(void* context);
+
+/*!
+    \brief     Timed event declaration
+    \details   Holds a scheduled event and its target statemachine.
+*/
+typedef struct {
+   sm_time_t time;               /*!< Point in time the event is due */
+   unsigned long long sequence;  /*!< Order of scheduling, for events due at the same point in time */
+   sm_t *sm;                     /*!< Target statemachine */
+   event_t event;                /*!< Scheduled event */
+   void *data;                   /*!< Data associated with the event */
+}sm_sim_event_t;
+
+/*!
+    \brief     Scheduler declaration
+    \details   Holds the pending timed events as binary heap ordered by due time,
+               the current time and the state of the random number generator.
+*/
+typedef struct {
+   sm_sim_event_t *events;       /*!< Storage for pending events */
+   size_t size;                  /*!< Number of entries of the storage */
+   size_t count;                 /*!< Number of pending events */
+   unsigned long long sequence;  /*!< Sequence number of the next scheduled event */
+   sm_time_t now;                /*!< Current point in time */
+   unsigned long long random;    /*!< State of the random number generator */
+   sm_clock_fp clock;            /*!< Clock to read time from, NULL for virtual time */
+   void *context;                /*!< Context of the clock */
+}sm_sim_t;
+
+
+void sm_sim_init(sm_sim_t *sim, sm_sim_event_t *events, size_t size, unsigned long long seed);
+void sm_sim_clock(sm_sim_t *sim, sm_clock_fp clock, void *context);
+sm_time_t sm_sim_now(sm_sim_t *sim);
+unsigned long sm_sim_random(sm_sim_t *sim);
+bool sm_sim_schedule(sm_sim_t *sim, sm_time_t delay, sm_t *sm, event_t event, void *data);
+size_t sm_sim_cancel(sm_sim_t *sim, sm_t *sm, event_t event);
+size_t sm_sim_run(sm_sim_t *sim, sm_time_t until);
+
+
+#endif /* SM_SIM_H_ */
@@ -60,19 +60,18 @@
    #define DBG(...)
 #endif
 
-bool guard = false; /*!< Guard condition variable as used in UML state chart */
-
 /*!
     \brief     State A entry function
     \details   Every state in a UML state chart can have an optional entry action, which is executed upon
                entry to a state. Entry actions are associated with states, not transitions. Regardless
                of how a state is entered, its entry action will be executed.
 
+   \param      sm       State machine instance
    \param      event    Triggering event
    \param      data     Data associated with the event
 
 */
-void A_entry(event_t event, void* data)
+void A_entry(sm_t* sm, event_t event, void* data)
 {
    DBG("A Entry\n");
 }
@@ -83,14 +82,17 @@ void A_entry(event_t event, void* data)
                it is called the triggering event, or simply the trigger. This function has to be
                implemented by the state machine designer for each state of the state machine.
 
+   \param      sm       State machine instance
    \param      event    Triggering event
    \param      data     Data associated with the event
 
    \returns    New state in case of external transition. Same state as before in case of
                self transition. NULL in case of internal or no transition.
 */
-const sm_state_t* A_transitions(event_t event, void* data)
+const sm_state_t* A_transitions(sm_t* sm, event_t event, void* data)
 {
+   statemachine_data_t *self = sm->data;
+
    switch(event)
    {
       case a:
@@ -101,7 +103,7 @@ const sm_state_t* A_transitions(event_t event, void* data)
          /* external transition with guard condition + internal transition */
          DBG("A Internal\n");
 
-         if(guard)
+         if(self && self->guard)
             return &statemachine_states[B];
 
          return &statemachine_states[C];
@@ -116,11 +118,12 @@ const sm_state_t* A_transitions(event_t event, void* data)
                exit from a state. Exit actions are associated with states, not transitions. Regardless
                of how a state is left, its exit action will be executed.
 
+   \param      sm       State machine instance
    \param      event    Triggering event
    \param      data     Data associated with the event
 
 */
-void A_exit(event_t event, void* data)
+void A_exit(sm_t* sm, event_t event, void* data)
 {
    DBG("A Exit\n");
 }
@@ -128,7 +131,7 @@ void A_exit(event_t event, void* data)
 
 
 
-void BeC_transition_effect(event_t event, void* data)
+void BeC_transition_effect(sm_t* sm, event_t event, void* data)
 {
    DBG("BeC Transition Effect\n");
 }
@@ -140,13 +143,14 @@ void BeC_transition_effect(event_t event, void* data)
                it is called the triggering event, or simply the trigger. This function has to be
                implemented by the state machine designer for each state of the state machine.
 
+   \param      sm       State machine instance
    \param      event    Triggering event
    \param      data     Data associated with the event
 
    \returns    New state in case of external transition. Same state as before in case of
                self transition. NULL in case of internal or no transition.
 */
-const sm_state_t* B_transitions(event_t event, void* data)
+const sm_state_t* B_transitions(sm_t* sm, event_t event, void* data)
 {
    switch(event)
    {
@@ -156,7 +160,7 @@ const sm_state_t* B_transitions(event_t event, void* data)
 
       case e:
          /* external action with transition action */
-         sm_transition_effect = BeC_transition_effect;
+         sm->effect = BeC_transition_effect;
          return &statemachine_states[C];
    }
 
@@ -169,11 +173,12 @@ const sm_state_t* B_transitions(event_t event, void* data)
                exit from a state. Exit actions are associated with states, not transitions. Regardless
                of how a state is left, its exit action will be executed.
 
+   \param      sm       State machine instance
    \param      event    Triggering event
    \param      data     Data associated with the event
 
 */
-void B_exit(event_t event, void* data)
+void B_exit(sm_t* sm, event_t event, void* data)
 {
    DBG("B Exit\n");
 }
@@ -186,11 +191,12 @@ void B_exit(event_t event, void* data)
                entry to a state. Entry actions are associated with states, not transitions. Regardless
                of how a state is entered, its entry action will be executed.
 
+   \param      sm       State machine instance
    \param      event    Triggering event
    \param      data     Data associated with the event
 
 */
-void C_entry(event_t event, void* data)
+void C_entry(sm_t* sm, event_t event, void* data)
 {
    DBG("C Entry\n");
 }
@@ -202,13 +208,14 @@ void C_entry(event_t event, void* data)
                it is called the triggering event, or simply the trigger. This function has to be
                implemented by the state machine designer for each state of the state machine.
 
+   \param      sm       State machine instance
    \param      event    Triggering event
    \param      data     Data associated with the event
 
    \returns    New state in case of external transition. Same state as before in case of
                self transition. NULL in case of internal or no transition.
 */
-const sm_state_t* C_transitions(event_t event, void* data)
+const sm_state_t* C_transitions(sm_t* sm, event_t event, void* data)
 {
    switch(event)
    {
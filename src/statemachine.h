@@ -53,6 +53,7 @@
 
 #include "sm.h"
 #include "stddef.h"
+#include "stdbool.h"
 
 /*!
     \brief     Enumeration of events
@@ -77,6 +78,15 @@ typedef enum {
    C     /*!< State with entry action, internal tranition and eternal transition */
 }statemachine_states_t;
 
+/*!
+    \brief     Statemachine data
+    \details   (Object-) Data of a statemachine instance, to be set as data of the sm_t
+               instance. All instances share the same state table.
+*/
+typedef struct {
+   bool guard;    /*!< Guard condition variable as used in UML state chart */
+}statemachine_data_t;
+
 
 extern const sm_state_t statemachine_states[];
 extern const size_t statemachine_state_count;
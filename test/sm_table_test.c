@@ -0,0 +1,248 @@
+/*! \copyright
+               Copyright (c) 2013, marco@bacchi.at
+               All rights reserved.
+
+               Redistribution and use in source and binary forms, with or without
+               modification, are permitted provided that the following conditions
+               are met:
+               1. Redistributions of source code must retain the above copyright
+                notice, this list of conditions and the following disclaimer.
+               2. Redistributions in binary form must reproduce the above copyright
+                notice, this list of conditions and the following disclaimer in the
+                documentation and/or other materials provided with the distribution.
+               3. The name of the author may not be used to endorse or promote
+                products derived from this software without specific prior
+                written permission.
+
+               THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS
+               OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+               ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+               DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+               GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+               INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+               WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+               NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+   \file       sm_table_test.c
+   \version    0000
+   \authors    marco@bacchi.at
+   \date       2013
+
+   \brief      Unittest of versioned state tables
+
+   \details    Covers publishing of versioned state tables, migration of running statemachines
+               by state id and map, the cascade of retirement along a chain of versions and the
+               rejection of transitions to states of another table.
+
+               Build and run from this directory:
+
+               gcc -std=c99 -Wall -I../src sm_table_test.c ../src/sm.c -o sm_table_test && ./sm_table_test
+
+               __Changelist__
+
+               Revision|Date    |Name  |Change
+               --------|--------|------|-------------------------------------------------
+               0000    |00.00.00|bacmar|Detailed Change Text
+*/
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "sm.h"
+
+/*! Event leading to the state table passed as event data */
+#define GOTO 1
+
+static unsigned int actions = 0; /*!< Number of invoked entry/exit actions */
+
+/*!
+   \brief      Counting entry/exit action
+*/
+static void count_action(sm_t* sm, event_t event, void* data)
+{
+   actions++;
+}
+
+/*!
+   \brief      Transitions function leading to the state passed as event data
+*/
+static const sm_state_t* goto_transitions(sm_t* sm, event_t event, void* data)
+{
+   if(event == GOTO)
+      return data;
+
+   return NULL;
+}
+
+/*! Three versions of a state table, all with the same behavior */
+static const sm_state_t v1_states[] = {
+   {count_action, goto_transitions, count_action},
+   {count_action, goto_transitions, count_action},
+   {count_action, goto_transitions, count_action}
+};
+static const sm_state_t v2_states[] = {
+   {count_action, goto_transitions, count_action},
+   {count_action, goto_transitions, count_action}
+};
+static const sm_state_t v3_states[] = {
+   {count_action, goto_transitions, count_action},
+   {count_action, goto_transitions, count_action}
+};
+
+/*! Maps state ids of v1 to v2, state 2 has been removed in v2 */
+static const size_t v1_to_v2[] = {0, 1, 1};
+
+
+/*!
+   \brief      Migration by map without invoking any actions
+*/
+static void test_migrate(void)
+{
+   static const size_t map[] = {1, 0, 0};
+   sm_table_t v1 = SM_TABLE_INIT(v1_states,3);
+   sm_table_t v2 = SM_TABLE_INIT(v2_states,2);
+   sm_t sm = SM_INIT(NULL);
+
+   assert(sm_init_table(&sm,&v1,0) == &v1_states[0]);
+   assert(sm_table_publish(&v1,&v2,map));
+   assert(!sm_table_retired(&v1));
+
+   actions = 0;
+   assert(sm_send(&sm,0,NULL) == &v2_states[1]);
+   assert(actions == 0);
+   assert(sm.table == &v2);
+   assert(sm_table_retired(&v1));
+   assert(v2.users == 1);
+
+   sm_terminate(&sm);
+   assert(v2.users == 0);
+}
+
+/*!
+   \brief      Publishing rejects invalid maps and a second successor
+*/
+static void test_publish(void)
+{
+   static const size_t invalid_map[] = {0, 1, 2};
+   sm_table_t v1 = SM_TABLE_INIT(v1_states,3);
+   sm_table_t v2 = SM_TABLE_INIT(v2_states,2);
+   sm_table_t v3 = SM_TABLE_INIT(v3_states,2);
+
+   assert(!sm_table_publish(&v1,&v2,NULL));
+   assert(!sm_table_publish(&v1,&v2,invalid_map));
+   assert(!sm_table_publish(&v2,&v2,NULL));
+   assert(sm_table_publish(&v2,&v3,NULL));
+   assert(!sm_table_publish(&v2,&v1,NULL));
+
+   /* no statemachines bound, retired right away */
+   assert(sm_table_retired(&v2));
+   assert(!sm_table_retired(&v3));
+}
+
+/*!
+   \brief      Intermediate versions retire only after their predecessors
+*/
+static void test_cascade(void)
+{
+   sm_table_t v1 = SM_TABLE_INIT(v1_states,3);
+   sm_table_t v2 = SM_TABLE_INIT(v2_states,2);
+   sm_table_t v3 = SM_TABLE_INIT(v3_states,2);
+   sm_t a = SM_INIT(NULL);
+   sm_t b = SM_INIT(NULL);
+
+   assert(sm_init_table(&a,&v1,1));
+   assert(sm_init_table(&b,&v1,0));
+   assert(sm_table_publish(&v1,&v2,v1_to_v2));
+   assert(sm_table_publish(&v2,&v3,NULL));
+
+   /* statemachines of v1 still have to pass through v2 */
+   assert(!sm_table_retired(&v1));
+   assert(!sm_table_retired(&v2));
+
+   assert(sm_send(&a,0,NULL) == &v3_states[1]);
+   assert(!sm_table_retired(&v1));
+   assert(!sm_table_retired(&v2));
+
+   /* last statemachine of v1 terminates, retirement cascades to v2 */
+   sm_terminate(&b);
+   assert(sm_table_retired(&v1));
+   assert(sm_table_retired(&v2));
+   assert(!sm_table_retired(&v3));
+   assert(v3.users == 1);
+
+   sm_terminate(&a);
+   assert(v3.users == 0);
+}
+
+/*!
+   \brief      Binding to a table with a successor binds to the latest version
+*/
+static void test_bind_latest(void)
+{
+   sm_table_t v1 = SM_TABLE_INIT(v1_states,3);
+   sm_table_t v2 = SM_TABLE_INIT(v2_states,2);
+   sm_t a = SM_INIT(NULL);
+   sm_t b = SM_INIT(NULL);
+
+   assert(sm_init_table(&a,&v1,0));
+   assert(sm_table_publish(&v1,&v2,v1_to_v2));
+   assert(sm_init_table(&b,&v1,1) == &v2_states[1]);
+   assert(b.table == &v2);
+
+   assert(sm_send(&a,0,NULL) == &v2_states[0]);
+   assert(v2.users == 2);
+
+   sm_terminate(&b);
+   assert(!sm_table_retired(&v2));
+
+   /* reinitialization releases the binding */
+   assert(sm_init(&a,&v1_states[0]));
+   assert(a.table == NULL);
+   assert(v2.users == 0);
+}
+
+/*!
+   \brief      Transitions to states of another table are rejected
+*/
+static void test_foreign_state(void)
+{
+   sm_table_t v1 = SM_TABLE_INIT(v1_states,3);
+   sm_table_t v2 = SM_TABLE_INIT(v2_states,2);
+   sm_t sm = SM_INIT(NULL);
+
+   assert(sm_init_table(&sm,&v1,0));
+   assert(sm_table_publish(&v1,&v2,v1_to_v2));
+
+   /* migrated to v2, the transition leads back to v1 */
+   assert(sm_send(&sm,GOTO,(void*)&v1_states[2]) == NULL);
+   assert(sm.state == &v2_states[0]);
+   assert(sm.table == &v2);
+
+   assert(sm_send(&sm,GOTO,(void*)&v2_states[1]) == &v2_states[1]);
+
+   sm_terminate(&sm);
+}
+
+
+/*!
+   \brief      Main entry point
+
+   \returns    EXIT_SUCCESS if all tests passed. Aborts otherwise.
+*/
+int main(void)
+{
+   test_migrate();
+   test_publish();
+   test_cascade();
+   test_bind_latest();
+   test_foreign_state();
+
+   printf("sm_table_test passed\n");
+
+   return EXIT_SUCCESS;
+}